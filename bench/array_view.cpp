@@ -0,0 +1,76 @@
+/*
+ * Copyright 2014 Nicola Gigante
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "bench.h"
+
+#include <std14/experimental/array_view>
+
+#include <numeric>
+#include <vector>
+
+namespace {
+
+    using std14::experimental::array_view;
+
+    std::vector<int> const&data() {
+        static std::vector<int> v = [] {
+            std::vector<int> v(4096);
+            std::iota(v.begin(), v.end(), 0);
+            return v;
+        }();
+        return v;
+    }
+
+    CPPUTILS_BENCHMARK("array_view/range_for/4096", [](std::size_t n) {
+        for(std::size_t i = 0; i < n; ++i) {
+            array_view<int> view = data();
+            bench::do_not_optimize(view);
+
+            int sum = 0;
+            for(int x : view)
+                sum += x;
+            bench::do_not_optimize(sum);
+        }
+    });
+
+    CPPUTILS_BENCHMARK("array_view/index/4096", [](std::size_t n) {
+        for(std::size_t i = 0; i < n; ++i) {
+            array_view<int> view = data();
+            bench::do_not_optimize(view);
+
+            int sum = 0;
+            for(std::size_t j = 0; j < view.size(); ++j)
+                sum += view[j];
+            bench::do_not_optimize(sum);
+        }
+    });
+
+    // Baseline
+    CPPUTILS_BENCHMARK("array_view/raw_pointer/4096", [](std::size_t n) {
+        for(std::size_t i = 0; i < n; ++i) {
+            int const *p = data().data();
+            std::size_t size = data().size();
+            bench::do_not_optimize(p);
+
+            int sum = 0;
+            for(std::size_t j = 0; j < size; ++j)
+                sum += p[j];
+            bench::do_not_optimize(sum);
+        }
+    });
+
+} // namespace
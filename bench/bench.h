@@ -0,0 +1,91 @@
+/*
+ * Copyright 2014 Nicola Gigante
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CPPUTILS_BENCH_H
+#define CPPUTILS_BENCH_H
+
+/*
+ * A tiny statistical microbenchmark harness.
+ *
+ * A benchmark is a function that runs its body a given number of times:
+ *
+ *     CPPUTILS_BENCHMARK("str_switch/16", [](std::size_t n) {
+ *         for(std::size_t i = 0; i < n; ++i)
+ *             bench::do_not_optimize(utils::str_switch(key));
+ *     });
+ *
+ * The harness warms it up, calibrates the number of iterations so that a
+ * repetition lasts at least --min-time milliseconds, and then times
+ * --repetitions repetitions, optionally reading hardware counters through
+ * perf_event_open. Results are written as JSON (see bench/compare.py to
+ * diff two runs) and as a human readable table on stderr.
+ *
+ * Setup that must not be timed can be done in function-local statics, which
+ * get initialized during the warmup.
+ */
+
+#include "utils/meta.h"
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#define CPPUTILS_BENCHMARK(NAME, ...)                                         \
+    static ::bench::registrar                                                 \
+    CPPUTILS_CONCAT__(cpputils_bench_registrar_, __LINE__)(NAME, __VA_ARGS__)
+
+namespace bench {
+
+    using function = std::function<void(std::size_t)>;
+
+    struct benchmark {
+        std::string name;
+        function body;
+    };
+
+    // All the registered benchmarks, in registration order
+    std::vector<benchmark> &registry();
+
+    struct registrar {
+        registrar(std::string name, function body) {
+            registry().push_back({ std::move(name), std::move(body) });
+        }
+    };
+
+    /*
+     * Prevents the compiler from optimizing away the computation of a value,
+     * or from assuming anything about memory, respectively.
+     */
+    template<typename T>
+    inline void do_not_optimize(T const&value) {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        static volatile char sink;
+        sink = *reinterpret_cast<char const volatile *>(&value);
+#endif
+    }
+
+    inline void clobber_memory() {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : : "memory");
+#endif
+    }
+
+} // namespace bench
+
+#endif
@@ -0,0 +1,73 @@
+#!/usr/bin/env python3
+#
+# Copyright 2014 Nicola Gigante
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""
+Compares two JSON outputs of cpputils_bench by median time per iteration.
+
+Usage: compare.py baseline.json current.json [--threshold=PERCENT]
+
+Exits with status 1 if any benchmark got slower than the threshold
+(default 5%), so it can be used to catch regressions.
+"""
+
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        return {b["name"]: b for b in json.load(f)["benchmarks"]}
+
+
+def main(argv):
+    threshold = 5.0
+    paths = []
+    for arg in argv[1:]:
+        if arg.startswith("--threshold="):
+            threshold = float(arg[len("--threshold="):])
+        else:
+            paths.append(arg)
+
+    if len(paths) != 2:
+        print(__doc__.strip(), file=sys.stderr)
+        return 2
+
+    baseline, current = load(paths[0]), load(paths[1])
+    regressions = 0
+
+    print("%-36s %12s %12s %9s" % ("benchmark", "baseline", "current", "change"))
+    for name, cur in current.items():
+        if name not in baseline:
+            print("%-36s %12s %12.2f %9s" %
+                  (name, "-", cur["ns_per_iteration"]["median"], "new"))
+            continue
+
+        old = baseline[name]["ns_per_iteration"]["median"]
+        new = cur["ns_per_iteration"]["median"]
+        change = (new - old) / old * 100 if old > 0 else 0.0
+        flag = ""
+        if change > threshold:
+            flag = "  <-- regression"
+            regressions += 1
+
+        print("%-36s %12.2f %12.2f %+8.1f%%%s" %
+              (name, old, new, change, flag))
+
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
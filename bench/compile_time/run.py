@@ -0,0 +1,154 @@
+#!/usr/bin/env python3
+#
+# Copyright 2014 Nicola Gigante
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""
+Compile-time benchmark of meta.h and has_member.h.
+
+Generates a translation unit with thousands of REQUIRES-constrained
+function templates (with variadic all()/any()/same_type() conditions) and
+has_member queries, and compiles it with -fsyntax-only against two versions
+of the headers:
+
+  legacy   the recursive implementation, kept verbatim in legacy/utils/
+  current  the headers in include/utils/
+
+For each one it reports the best wall time over a few runs and the peak
+memory of the compiler, as a table and optionally as JSON.
+
+Usage: run.py [--compiler=CXX] [--std=17] [--overloads=N] [--runs=N]
+              [--work-dir=DIR] [--json=PATH]
+"""
+
+import json
+import os
+import subprocess
+import sys
+import time
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+VARIANTS = [
+    ("legacy", os.path.join(HERE, "legacy")),
+    ("current", os.path.join(HERE, "..", "..", "include")),
+]
+
+
+def generate(overloads):
+    out = [
+        '#include <type_traits>',
+        '#include <utility>',
+        '#include "utils/meta.h"',
+        '#include "utils/has_member.h"',
+        '',
+        'using namespace utils;',
+        '',
+        'template<int> struct tag { };',
+        '',
+        'DECLARE_HAS_MEMBER_TRAIT(get)',
+        '',
+    ]
+
+    for i in range(overloads):
+        arity = i % 16 + 1
+        args = ", ".join(str(n) for n in range(arity))
+        out += [
+            # Two overloads per function, both constrained on the whole pack
+            'template<typename ...Args,',
+            '         REQUIRES(sizeof...(Args) == %d,' % arity,
+            '                  std::is_integral<Args>()...,',
+            '                  neg(any(std::is_pointer<Args>()...)))>',
+            'int f%d(Args ...args) { return int(sizeof...(args)); }' % i,
+            'template<typename ...Args,',
+            '         REQUIRES(any(std::is_floating_point<Args>()...),',
+            '                  same_type<double, Args...>())>',
+            'int f%d(Args ...args) { return -int(sizeof...(args)); }' % i,
+            'struct s%d { int get(tag<%d>) const; };' % (i, i),
+            'static_assert(has_member_get_trait<s%d, int(tag<%d>)>::value, "");'
+            % (i, i),
+            'static_assert(!has_member_get_trait<s%d, int(tag<%d>)>::value, "");'
+            % (i, i + 1),
+            'int call%d() { return f%d(%s) + f%d(1.0, 2.0); }'
+            % (i, i, args, i),
+            '',
+        ]
+
+    return "\n".join(out) + "\n"
+
+
+def compile_once(compiler, std, include, source):
+    cmd = [compiler, "-std=c++%s" % std, "-fsyntax-only",
+           "-I", include, source]
+    start = time.monotonic()
+    proc = subprocess.Popen(cmd)
+    _, status, usage = os.wait4(proc.pid, 0)
+    elapsed = time.monotonic() - start
+    proc.returncode = os.waitstatus_to_exitcode(status)
+    if proc.returncode != 0:
+        raise RuntimeError("Compilation failed: %s" % " ".join(cmd))
+    # ru_maxrss is in kilobytes on Linux, in bytes on macOS
+    rss = usage.ru_maxrss * (1 if sys.platform == "darwin" else 1024)
+    return elapsed, rss
+
+
+def main(argv):
+    opts = {
+        "compiler": os.environ.get("CXX", "c++"),
+        "std": "17",
+        "overloads": "2000",
+        "runs": "3",
+        "work-dir": ".",
+        "json": "",
+    }
+    for arg in argv[1:]:
+        key, _, value = arg.lstrip("-").partition("=")
+        if key not in opts:
+            print(__doc__.strip(), file=sys.stderr)
+            return 2
+        opts[key] = value
+
+    os.makedirs(opts["work-dir"], exist_ok=True)
+    source = os.path.join(opts["work-dir"], "compile_bench.cpp")
+    with open(source, "w") as f:
+        f.write(generate(int(opts["overloads"])))
+
+    results = []
+    for name, include in VARIANTS:
+        runs = [compile_once(opts["compiler"], opts["std"], include, source)
+                for _ in range(int(opts["runs"]))]
+        results.append({
+            "name": name,
+            "seconds": min(r[0] for r in runs),
+            "peak_memory_bytes": max(r[1] for r in runs),
+        })
+
+    print("%d overloads, %s -std=c++%s" %
+          (int(opts["overloads"]) * 2, opts["compiler"], opts["std"]))
+    print("%-10s %10s %14s" % ("headers", "seconds", "peak MiB"))
+    for r in results:
+        print("%-10s %10.2f %14.1f" %
+              (r["name"], r["seconds"], r["peak_memory_bytes"] / 2**20))
+
+    if opts["json"]:
+        with open(opts["json"], "w") as f:
+            json.dump({"overloads": int(opts["overloads"]) * 2,
+                       "compiler": opts["compiler"],
+                       "std": opts["std"],
+                       "results": results}, f, indent=2)
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
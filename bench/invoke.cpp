@@ -0,0 +1,85 @@
+/*
+ * Copyright 2014 Nicola Gigante
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "bench.h"
+
+#include "utils/invoke.h"
+
+#include <tuple>
+
+namespace {
+
+    int add(int a, int b) { return a + b; }
+
+    struct S {
+        int member = 42;
+        int add(int a) const { return member + a; }
+    };
+
+    // Each benchmark should take the same time as the direct call
+    CPPUTILS_BENCHMARK("invoke/direct_call", [](std::size_t n) {
+        for(std::size_t i = 0; i < n; ++i) {
+            int a = int(i);
+            bench::do_not_optimize(a);
+            bench::do_not_optimize(add(a, 1));
+        }
+    });
+
+    CPPUTILS_BENCHMARK("invoke/function", [](std::size_t n) {
+        for(std::size_t i = 0; i < n; ++i) {
+            int a = int(i);
+            bench::do_not_optimize(a);
+            bench::do_not_optimize(utils::invoke(add, a, 1));
+        }
+    });
+
+    CPPUTILS_BENCHMARK("invoke/member_function", [](std::size_t n) {
+        S s;
+        for(std::size_t i = 0; i < n; ++i) {
+            int a = int(i);
+            bench::do_not_optimize(a);
+            bench::do_not_optimize(utils::invoke(&S::add, s, a));
+        }
+    });
+
+    CPPUTILS_BENCHMARK("invoke/member_pointer", [](std::size_t n) {
+        S s;
+        for(std::size_t i = 0; i < n; ++i) {
+            bench::do_not_optimize(s);
+            bench::do_not_optimize(utils::invoke(&S::member, &s));
+        }
+    });
+
+    CPPUTILS_BENCHMARK("invoke/invokable", [](std::size_t n) {
+        S s;
+        auto f = utils::invokable(&S::add);
+        for(std::size_t i = 0; i < n; ++i) {
+            int a = int(i);
+            bench::do_not_optimize(a);
+            bench::do_not_optimize(f(s, a));
+        }
+    });
+
+    CPPUTILS_BENCHMARK("invoke/apply", [](std::size_t n) {
+        for(std::size_t i = 0; i < n; ++i) {
+            auto args = std::make_tuple(int(i), 1);
+            bench::do_not_optimize(args);
+            bench::do_not_optimize(utils::apply(add, args));
+        }
+    });
+
+} // namespace
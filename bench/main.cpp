@@ -0,0 +1,421 @@
+/*
+ * Copyright 2014 Nicola Gigante
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Driver of the cpputils_bench microbenchmark suite.
+ *
+ * Usage: cpputils_bench [options]
+ *   --filter=STR      run only benchmarks whose name contains STR
+ *   --repetitions=N   timed repetitions per benchmark (default 10)
+ *   --min-time=MS     minimum duration of a repetition (default 20)
+ *   --cpu=N           pin to CPU N, -1 to disable (default: current CPU)
+ *   --json=PATH       write the JSON results to PATH instead of stdout
+ *   --list            only print the names of the benchmarks
+ */
+
+#include "bench.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+# include <linux/perf_event.h>
+# include <sched.h>
+# include <sys/ioctl.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+#endif
+
+namespace bench {
+
+    std::vector<benchmark> &registry() {
+        static std::vector<benchmark> r;
+        return r;
+    }
+
+namespace {
+
+    struct options {
+        std::string filter;
+        std::size_t repetitions = 10;
+        double min_time = 0.020; // seconds
+        int cpu = -2;            // -2 means the current one
+        std::string json;
+        bool list = false;
+    };
+
+    /*
+     * Hardware counters read as a group through perf_event_open, so that
+     * they're all enabled and disabled at the same time. If the kernel has
+     * to multiplex the group with other events, the counts are scaled by
+     * the fraction of the time it was actually running. Counters that
+     * can't be opened (no PMU in a VM, perf_event_paranoid, non-Linux
+     * systems) are silently left out.
+     */
+    class perf_counters
+    {
+    public:
+        perf_counters() {
+#ifdef __linux__
+            add("cycles", PERF_COUNT_HW_CPU_CYCLES);
+            add("instructions", PERF_COUNT_HW_INSTRUCTIONS);
+            add("branch_misses", PERF_COUNT_HW_BRANCH_MISSES);
+            add("cache_misses", PERF_COUNT_HW_CACHE_MISSES);
+#endif
+        }
+
+        ~perf_counters() {
+#ifdef __linux__
+            for(int fd : _fds)
+                close(fd);
+#endif
+        }
+
+        perf_counters(perf_counters const&) = delete;
+        perf_counters &operator=(perf_counters const&) = delete;
+
+        std::vector<std::string> const&names() const { return _names; }
+
+        void start() {
+#ifdef __linux__
+            if(_fds.empty())
+                return;
+            ioctl(_fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(_fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+        }
+
+        // Adds the counted values to totals
+        void stop(std::vector<double> &totals) {
+            totals.resize(_names.size());
+#ifdef __linux__
+            if(_fds.empty())
+                return;
+            ioctl(_fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+            // Number of counters, time enabled, time running, values
+            std::vector<uint64_t> values(_fds.size() + 3);
+            ssize_t size = ssize_t(values.size() * sizeof(uint64_t));
+            if(read(_fds[0], values.data(), size_t(size)) != size)
+                return;
+
+            // The times aren't reset with the counts, but they don't advance
+            // while the group is disabled, so take the difference
+            uint64_t enabled = values[1] - _enabled;
+            uint64_t running = values[2] - _running;
+            _enabled = values[1];
+            _running = values[2];
+            if(running == 0)
+                return;
+
+            double scale = double(enabled) / double(running);
+            for(std::size_t i = 0; i < _names.size(); ++i)
+                totals[i] += double(values[i + 3]) * scale;
+#endif
+        }
+
+    private:
+#ifdef __linux__
+        void add(char const *name, uint64_t config) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = config;
+            attr.disabled = _fds.empty() ? 1 : 0;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP |
+                               PERF_FORMAT_TOTAL_TIME_ENABLED |
+                               PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            int leader = _fds.empty() ? -1 : _fds[0];
+            long fd = syscall(__NR_perf_event_open, &attr, 0, -1, leader, 0);
+            if(fd < 0)
+                return;
+
+            _fds.push_back(int(fd));
+            _names.push_back(name);
+        }
+
+        std::vector<int> _fds;
+        uint64_t _enabled = 0;
+        uint64_t _running = 0;
+#endif
+        std::vector<std::string> _names;
+    };
+
+    struct result {
+        std::string name;
+        std::size_t iterations = 0;
+        std::vector<double> samples; // ns per iteration, sorted
+        std::vector<double> counters; // per iteration
+
+        double min() const { return samples.front(); }
+        double max() const { return samples.back(); }
+
+        double median() const {
+            std::size_t n = samples.size();
+            return n % 2 ? samples[n / 2]
+                         : (samples[n / 2 - 1] + samples[n / 2]) / 2;
+        }
+
+        double mean() const {
+            double sum = 0;
+            for(double s : samples)
+                sum += s;
+            return sum / double(samples.size());
+        }
+
+        double stddev() const {
+            if(samples.size() < 2)
+                return 0;
+            double m = mean(), sum = 0;
+            for(double s : samples)
+                sum += (s - m) * (s - m);
+            return std::sqrt(sum / double(samples.size() - 1));
+        }
+    };
+
+    double seconds(function const&body, std::size_t iterations) {
+        auto start = std::chrono::steady_clock::now();
+        body(iterations);
+        auto stop = std::chrono::steady_clock::now();
+        return std::chrono::duration<double>(stop - start).count();
+    }
+
+    result run(benchmark const&b, options const&opts, perf_counters &perf)
+    {
+        result r;
+        r.name = b.name;
+
+        // Warmup and calibration: grow the iterations until a run lasts
+        // at least min_time, then scale to hit it
+        std::size_t n = 1;
+        double elapsed = seconds(b.body, n);
+        while(elapsed < opts.min_time) {
+            std::size_t next = elapsed > 0
+                ? std::size_t(double(n) * opts.min_time / elapsed * 1.2) + 1
+                : n * 10;
+            n = std::min(std::max(next, n * 2), n * 100);
+            elapsed = seconds(b.body, n);
+        }
+        r.iterations = n;
+
+        std::vector<double> totals;
+        for(std::size_t i = 0; i < opts.repetitions; ++i) {
+            perf.start();
+            double s = seconds(b.body, n);
+            perf.stop(totals);
+            r.samples.push_back(s * 1e9 / double(n));
+        }
+        std::sort(r.samples.begin(), r.samples.end());
+
+        for(double t : totals)
+            r.counters.push_back(t / double(n * opts.repetitions));
+
+        return r;
+    }
+
+    bool pin(int cpu)
+    {
+#ifdef __linux__
+        if(cpu == -2)
+            cpu = sched_getcpu();
+        if(cpu < 0)
+            return false;
+
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+        static_cast<void>(cpu);
+        return false;
+#endif
+    }
+
+    int current_cpu() {
+#ifdef __linux__
+        return sched_getcpu();
+#else
+        return -1;
+#endif
+    }
+
+    std::string compiler() {
+#if defined(__VERSION__)
+        return __VERSION__;
+#elif defined(_MSC_FULL_VER)
+        return "MSVC " + std::to_string(_MSC_FULL_VER);
+#else
+        return "unknown";
+#endif
+    }
+
+    std::string escaped(std::string const&str) {
+        std::string out;
+        for(char c : str) {
+            if(c == '"' || c == '\\')
+                out += '\\';
+            out += c;
+        }
+        return out;
+    }
+
+    void write_json(std::ostream &out, std::vector<result> const&results,
+                    std::vector<std::string> const&counters,
+                    options const&opts, bool pinned)
+    {
+        out.precision(17);
+        out << "{\n  \"context\": {\n"
+            << "    \"compiler\": \"" << escaped(compiler()) << "\",\n"
+#ifdef NDEBUG
+            << "    \"assertions\": false,\n"
+#else
+            << "    \"assertions\": true,\n"
+#endif
+            << "    \"hardware_concurrency\": "
+            << std::thread::hardware_concurrency() << ",\n"
+            << "    \"pinned_cpu\": " << (pinned ? current_cpu() : -1) << ",\n"
+            << "    \"repetitions\": " << opts.repetitions << ",\n"
+            << "    \"min_time_ms\": " << opts.min_time * 1000 << "\n"
+            << "  },\n  \"benchmarks\": [";
+
+        bool first = true;
+        for(auto const&r : results) {
+            out << (first ? "\n" : ",\n")
+                << "    {\n"
+                << "      \"name\": \"" << escaped(r.name) << "\",\n"
+                << "      \"iterations\": " << r.iterations << ",\n"
+                << "      \"ns_per_iteration\": {"
+                << " \"min\": " << r.min()
+                << ", \"median\": " << r.median()
+                << ", \"mean\": " << r.mean()
+                << ", \"max\": " << r.max()
+                << ", \"stddev\": " << r.stddev() << " },\n"
+                << "      \"counters_per_iteration\": {";
+            for(std::size_t i = 0; i < counters.size(); ++i)
+                out << (i ? ", " : " ") << '"' << counters[i] << "\": "
+                    << r.counters[i];
+            out << (counters.empty() ? "}" : " }") << "\n    }";
+            first = false;
+        }
+
+        out << "\n  ]\n}\n";
+    }
+
+    void print_row(result const&r, std::vector<std::string> const&counters)
+    {
+        double m = r.median();
+        std::fprintf(stderr, "%-36s %12.2f %7.1f%%",
+                     r.name.c_str(), m, m > 0 ? r.stddev() / m * 100 : 0.0);
+        for(std::size_t i = 0; i < counters.size() && i < 2; ++i)
+            std::fprintf(stderr, " %14.2f", r.counters[i]);
+        std::fprintf(stderr, "\n");
+    }
+
+    bool parse(int argc, char *argv[], options &opts)
+    {
+        for(int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&](char const *prefix) -> char const * {
+                std::size_t len = std::strlen(prefix);
+                return arg.compare(0, len, prefix) == 0 ? argv[i] + len
+                                                        : nullptr;
+            };
+
+            if(char const *v = value("--filter="))
+                opts.filter = v;
+            else if(char const *v = value("--repetitions="))
+                opts.repetitions = std::max(1ul, std::strtoul(v, nullptr, 10));
+            else if(char const *v = value("--min-time="))
+                opts.min_time = std::strtod(v, nullptr) / 1000;
+            else if(char const *v = value("--cpu="))
+                opts.cpu = int(std::strtol(v, nullptr, 10));
+            else if(char const *v = value("--json="))
+                opts.json = v;
+            else if(arg == "--list")
+                opts.list = true;
+            else {
+                std::fprintf(stderr, "Unknown option: %s\n", argv[i]);
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+} // namespace
+} // namespace bench
+
+int main(int argc, char *argv[])
+{
+    using namespace bench;
+
+    options opts;
+    if(!parse(argc, argv, opts))
+        return 1;
+
+    std::vector<benchmark const *> selected;
+    for(auto const&b : registry())
+        if(b.name.find(opts.filter) != std::string::npos)
+            selected.push_back(&b);
+
+    if(opts.list) {
+        for(auto b : selected)
+            std::printf("%s\n", b->name.c_str());
+        return 0;
+    }
+
+    bool pinned = pin(opts.cpu);
+    perf_counters perf;
+    auto const&counters = perf.names();
+
+    std::fprintf(stderr, "%-36s %12s %8s", "benchmark", "ns/iter", "stddev");
+    for(std::size_t i = 0; i < counters.size() && i < 2; ++i)
+        std::fprintf(stderr, " %14s", (counters[i] + "/iter").c_str());
+    std::fprintf(stderr, "\n");
+
+    std::vector<result> results;
+    for(auto b : selected) {
+        results.push_back(run(*b, opts, perf));
+        print_row(results.back(), counters);
+    }
+
+    if(opts.json.empty())
+        write_json(std::cout, results, counters, opts, pinned);
+    else {
+        std::ofstream out(opts.json);
+        write_json(out, results, counters, opts, pinned);
+        if(!out) {
+            std::fprintf(stderr, "Unable to write %s\n", opts.json.c_str());
+            return 1;
+        }
+    }
+
+    return 0;
+}
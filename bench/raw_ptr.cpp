@@ -0,0 +1,72 @@
+/*
+ * Copyright 2014 Nicola Gigante
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "bench.h"
+
+#include "utils/raw_ptr.h"
+
+#include <utility>
+
+namespace {
+
+    struct node {
+        utils::ptr<int> p;
+    };
+
+    // Moves of utils::ptr swap instead of copying
+    CPPUTILS_BENCHMARK("ptr/move_construct", [](std::size_t n) {
+        int x = 42;
+        utils::ptr<int> p(&x);
+        for(std::size_t i = 0; i < n; ++i) {
+            utils::ptr<int> q(std::move(p));
+            bench::do_not_optimize(q);
+            p = std::move(q);
+        }
+    });
+
+    CPPUTILS_BENCHMARK("ptr/move_assign", [](std::size_t n) {
+        int x = 42, y = 43;
+        utils::ptr<int> p(&x), q(&y);
+        for(std::size_t i = 0; i < n; ++i) {
+            q = std::move(p);
+            bench::do_not_optimize(q);
+            bench::do_not_optimize(p);
+        }
+    });
+
+    CPPUTILS_BENCHMARK("ptr/member_move", [](std::size_t n) {
+        int x = 42;
+        node a { utils::ptr<int>(&x) }, b;
+        for(std::size_t i = 0; i < n; ++i) {
+            b = std::move(a);
+            bench::do_not_optimize(b);
+            a = std::move(b);
+        }
+    });
+
+    // Baseline
+    CPPUTILS_BENCHMARK("ptr/raw_pointer_copy", [](std::size_t n) {
+        int x = 42, y = 43;
+        int *p = &x, *q = &y;
+        for(std::size_t i = 0; i < n; ++i) {
+            q = p;
+            bench::do_not_optimize(q);
+            bench::do_not_optimize(p);
+        }
+    });
+
+} // namespace
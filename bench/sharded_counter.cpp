@@ -0,0 +1,100 @@
+/*
+ * Copyright 2014 Nicola Gigante
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Compares the throughput of utils::sharded_counter against a single
+ * std::atomic counter incremented by 1 to N threads.
+ *
+ * Usage: sharded_counter_bench [max threads] [increments per thread]
+ */
+
+#include "utils/sharded_counter.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    template<typename Counter>
+    double run(Counter &counter, unsigned threads, std::size_t increments)
+    {
+        std::atomic<bool> go{false};
+        std::vector<std::thread> workers;
+
+        for(unsigned i = 0; i < threads; ++i)
+            workers.emplace_back([&] {
+                while(!go.load(std::memory_order_acquire))
+                    std::this_thread::yield();
+                for(std::size_t n = 0; n < increments; ++n)
+                    ++counter;
+            });
+
+        auto start = std::chrono::steady_clock::now();
+        go.store(true, std::memory_order_release);
+        for(auto &w : workers)
+            w.join();
+        auto stop = std::chrono::steady_clock::now();
+
+        if(std::size_t(counter) != threads * increments) {
+            std::fprintf(stderr, "Lost increments!\n");
+            std::abort();
+        }
+
+        std::chrono::duration<double> elapsed = stop - start;
+        return double(threads * increments) / elapsed.count() / 1e6;
+    }
+
+    // std::atomic has an implicit conversion, sharded_counter an explicit one
+    struct single_atomic {
+        std::atomic<std::size_t> value{0};
+
+        void operator++() { value.fetch_add(1, std::memory_order_relaxed); }
+        explicit operator std::size_t() const { return value.load(); }
+    };
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    unsigned max_threads = std::thread::hardware_concurrency();
+    std::size_t increments = 10000000;
+
+    if(argc > 1)
+        max_threads = unsigned(std::strtoul(argv[1], nullptr, 10));
+    if(argc > 2)
+        increments = std::strtoull(argv[2], nullptr, 10);
+    if(max_threads == 0)
+        max_threads = 1;
+
+    std::printf("%8s %18s %18s %8s\n",
+                "threads", "atomic (Mops/s)", "sharded (Mops/s)", "speedup");
+
+    for(unsigned threads = 1; threads <= max_threads; ++threads) {
+        single_atomic atomic;
+        utils::sharded_counter<> sharded;
+
+        double a = run(atomic, threads, increments);
+        double s = run(sharded, threads, increments);
+
+        std::printf("%8u %18.1f %18.1f %7.2fx\n", threads, a, s, s / a);
+    }
+
+    return 0;
+}
@@ -0,0 +1,181 @@
+/*
+ * Copyright 2014 Nicola Gigante
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/*
+ * Compares utils::string_builder with std::string and std::ostringstream,
+ * building both short log lines and large responses, by throughput and by
+ * number of heap allocations (counted by replacing the global operator new).
+ *
+ * Usage: string_builder_bench [repetitions]
+ */
+
+#include "bench.h"
+
+#include "utils/string_builder.h"
+
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <sstream>
+#include <string>
+
+namespace {
+    std::size_t allocations = 0;
+}
+
+void *operator new(std::size_t size)
+{
+    ++allocations;
+    if(void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+    // The same fields are appended by every contender. Latencies are
+    // multiples of 0.25 with at most six digits, so that the shortest
+    // representation and the default stream precision agree.
+    struct fields {
+        static constexpr char const *method = "GET";
+        static constexpr char const *path = "/api/v1/items";
+
+        static double latency(std::size_t i) { return double(i % 4000) / 4; }
+    };
+
+    std::size_t with_string(std::size_t lines)
+    {
+        std::string s;
+        for(std::size_t i = 0; i < lines; ++i) {
+            s += fields::method;
+            s += ' ';
+            s += fields::path;
+            s += " id=";
+            s += std::to_string(i);
+            s += " status=";
+            s += std::to_string(200 + int(i % 5));
+            s += " latency=";
+            char buf[32];
+            s.append(buf, std::to_chars(buf, buf + sizeof(buf),
+                                        fields::latency(i)).ptr);
+            s += '\n';
+        }
+        bench::do_not_optimize(s.data());
+        return s.size();
+    }
+
+    std::size_t with_ostringstream(std::size_t lines)
+    {
+        std::ostringstream s;
+        for(std::size_t i = 0; i < lines; ++i)
+            s << fields::method << ' ' << fields::path << " id=" << i
+              << " status=" << 200 + int(i % 5)
+              << " latency=" << fields::latency(i) << '\n';
+
+        std::string result = s.str();
+        bench::do_not_optimize(result.data());
+        return result.size();
+    }
+
+    std::size_t with_builder(std::size_t lines)
+    {
+        utils::string_builder s;
+        for(std::size_t i = 0; i < lines; ++i)
+            s << fields::method << ' ' << fields::path << " id=" << i
+              << " status=" << 200 + int(i % 5)
+              << " latency=" << fields::latency(i) << '\n';
+
+        auto view = s.str();
+        bench::do_not_optimize(view.data());
+        return view.size();
+    }
+
+    std::size_t with_builder_chunks(std::size_t lines)
+    {
+        utils::string_builder s;
+        for(std::size_t i = 0; i < lines; ++i)
+            s << fields::method << ' ' << fields::path << " id=" << i
+              << " status=" << 200 + int(i % 5)
+              << " latency=" << fields::latency(i) << '\n';
+
+        auto chunks = s.chunks();
+        bench::do_not_optimize(chunks.data());
+        return s.size();
+    }
+
+    std::size_t run(char const *name, std::size_t (*f)(std::size_t),
+                    std::size_t lines, std::size_t repetitions)
+    {
+        std::size_t bytes = 0;
+        std::size_t before = allocations;
+
+        auto start = std::chrono::steady_clock::now();
+        for(std::size_t r = 0; r < repetitions; ++r)
+            bytes += f(lines);
+        auto stop = std::chrono::steady_clock::now();
+
+        double seconds = std::chrono::duration<double>(stop - start).count();
+        std::printf("%-28s %12.1f %18.2f\n", name,
+                    double(bytes) / seconds / 1e6,
+                    double(allocations - before) / double(repetitions));
+
+        return bytes;
+    }
+
+    void scenario(char const *title, std::size_t lines,
+                  std::size_t repetitions)
+    {
+        std::printf("\n%s (%zu lines)\n", title, lines);
+        std::printf("%-28s %12s %18s\n", "", "MB/s", "allocations/build");
+
+        std::size_t bytes[] = {
+            run("std::string", with_string, lines, repetitions),
+            run("std::ostringstream", with_ostringstream, lines, repetitions),
+            run("string_builder::str()", with_builder, lines, repetitions),
+            run("string_builder::chunks()", with_builder_chunks, lines,
+                repetitions)
+        };
+
+        // Otherwise the throughputs wouldn't be comparable
+        for(std::size_t b : bytes)
+            if(b != bytes[0]) {
+                std::fprintf(stderr, "Contenders produced different output\n");
+                std::exit(1);
+            }
+    }
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    std::size_t repetitions = 200000;
+    if(argc > 1)
+        repetitions = std::strtoull(argv[1], nullptr, 10);
+    if(repetitions < 100)
+        repetitions = 100;
+
+    scenario("Single log line", 1, repetitions);
+    scenario("Small response", 20, repetitions / 20);
+    scenario("Large response", 20000, repetitions / 20000 + 1);
+
+    return 0;
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright 2014 Nicola Gigante
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "bench.h"
+
+#include "utils/string_switch.h"
+
+#include <string>
+
+namespace {
+
+    void hash(std::size_t n, std::size_t length) {
+        std::string key(length, 'k');
+
+        for(std::size_t i = 0; i < n; ++i) {
+            std::string_view view = key;
+            bench::do_not_optimize(view);
+            bench::do_not_optimize(utils::str_switch(view));
+        }
+    }
+
+    CPPUTILS_BENCHMARK("str_switch/4",   [](std::size_t n) { hash(n, 4);   });
+    CPPUTILS_BENCHMARK("str_switch/16",  [](std::size_t n) { hash(n, 16);  });
+    CPPUTILS_BENCHMARK("str_switch/64",  [](std::size_t n) { hash(n, 64);  });
+    CPPUTILS_BENCHMARK("str_switch/256", [](std::size_t n) { hash(n, 256); });
+
+    // A whole switch, as it's meant to be used
+    CPPUTILS_BENCHMARK("str_switch/dispatch", [](std::size_t n) {
+        using namespace utils::literals;
+        static std::string const keys[] = { "get", "put", "delete", "head" };
+
+        for(std::size_t i = 0; i < n; ++i) {
+            std::string_view key = keys[i % 4];
+            bench::do_not_optimize(key);
+
+            int r = 0;
+            switch(utils::str_switch(key)) {
+                case "get"_match:    r = 1; break;
+                case "put"_match:    r = 2; break;
+                case "delete"_match: r = 3; break;
+                case "head"_match:   r = 4; break;
+            }
+            bench::do_not_optimize(r);
+        }
+    });
+
+} // namespace
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2014 Nicola Gigante
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "bench.h"
+
+#include <std14/experimental/string_view>
+
+#include <string>
+
+namespace {
+
+    using std14::experimental::string_view;
+
+    void compare(std::size_t n, std::size_t length) {
+        std::string a(length, 'a'), b(length, 'a');
+        b.back() = 'b';
+
+        for(std::size_t i = 0; i < n; ++i) {
+            string_view va = a, vb = b;
+            bench::do_not_optimize(va);
+            bench::do_not_optimize(vb);
+            bench::do_not_optimize(va.compare(vb));
+        }
+    }
+
+    void equal(std::size_t n, std::size_t length, std::size_t other) {
+        std::string a(length, 'a'), b(other, 'a');
+
+        for(std::size_t i = 0; i < n; ++i) {
+            string_view va = a, vb = b;
+            bench::do_not_optimize(va);
+            bench::do_not_optimize(vb);
+            bench::do_not_optimize(va == vb);
+        }
+    }
+
+    CPPUTILS_BENCHMARK("string_view/compare/16", [](std::size_t n) {
+        compare(n, 16);
+    });
+
+    CPPUTILS_BENCHMARK("string_view/compare/1024", [](std::size_t n) {
+        compare(n, 1024);
+    });
+
+    CPPUTILS_BENCHMARK("string_view/equal/16", [](std::size_t n) {
+        equal(n, 16, 16);
+    });
+
+    CPPUTILS_BENCHMARK("string_view/equal/1024", [](std::size_t n) {
+        equal(n, 1024, 1024);
+    });
+
+    CPPUTILS_BENCHMARK("string_view/equal/different_size", [](std::size_t n) {
+        equal(n, 1024, 1023);
+    });
+
+} // namespace
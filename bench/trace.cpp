@@ -0,0 +1,38 @@
+/*
+ * Copyright 2014 Nicola Gigante
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define UTILS_ENABLE_TRACING
+
+#include "bench.h"
+
+#include "utils/trace.h"
+
+namespace {
+
+    // Events are collected periodically, as a background flusher would do,
+    // so the buffer never fills up and the cost of collection is included.
+    CPPUTILS_BENCHMARK("trace/scope", [](std::size_t n) {
+        auto &tracer = utils::tracer::instance();
+        for(std::size_t i = 0; i < n; ++i) {
+            UTILS_TRACE_SCOPE("bench");
+            if(i % 4096 == 4095)
+                tracer.collect();
+        }
+        tracer.collect();
+    });
+
+} // namespace
@@ -17,6 +17,11 @@
 #ifndef CPPUTILS_HAS_MEMBER_H
 #define CPPUTILS_HAS_MEMBER_H
 
+#include "meta.h"
+
+#include <type_traits>
+#include <utility>
+
 /*
  * Traits utilities to recognize the existence of a member function in a class.
  *
@@ -28,6 +33,12 @@
  * the 'has_member_save_tag' type if the member exists and can be called,
  * and 'doesnt_have_member_save_tag' otherwise. This allows an easy tag dispatch.
  *
+ * The check is a single partial specialization matched through a void
+ * decltype, so each query costs one class template instantiation and no
+ * overload resolution. The expression is spelled out instead of being
+ * wrapped in void_t, because compilers affected by CWG 1558 don't apply
+ * SFINAE to unused alias template arguments.
+ *
  *
  *     DECLARE_HAS_MEMBER_TRAIT(save)
  *
@@ -52,31 +63,23 @@
 struct has_member_##Member##_tag : public std::true_type {};                   \
 struct doesnt_have_member_##Member##_tag : public std::false_type {};          \
                                                                                \
-template<typename T, typename S = void,                                        \
-         bool _ = std::is_class<T>::value>                                     \
+template<typename T, typename S = void, typename = void>                       \
 struct has_member_##Member##_trait : public std::false_type {                  \
     using type = doesnt_have_member_##Member##_tag;                            \
 };                                                                             \
                                                                                \
 template<typename T, typename R, typename ...Args>                             \
-struct has_member_##Member##_trait<T, R(Args...), true>                        \
+struct has_member_##Member##_trait<T, R(Args...),                              \
+    typename std::enable_if<std::is_class<T>::value, decltype(void(            \
+        std::declval<T>().Member(std::declval<Args>()...)))>::type>            \
 {                                                                              \
 private:                                                                       \
-    template<typename TT, typename ...AArgs>                                   \
-    static auto invoke(TT &&obj, AArgs&& ...args)                              \
-        -> decltype(std::forward<TT>(obj).Member(std::forward<AArgs>(args)...),\
-                    std::true_type());                                         \
-                                                                               \
-    static std::false_type invoke(...);                                        \
-                                                                               \
-    using _return_type = decltype(invoke(std::declval<T>(),                    \
-                                         std::declval<Args>()...));            \
-    static const bool _has_member = _return_type::value;                       \
+    using _return_type =                                                       \
+        decltype(std::declval<T>().Member(std::declval<Args>()...));           \
                                                                                \
 public:                                                                        \
-    static const bool value = _has_member &&                                   \
-                             (std::is_void<R>::value ||                        \
-                              std::is_convertible<_return_type, R>::value);    \
+    static const bool value = std::is_void<R>::value ||                        \
+                              std::is_convertible<_return_type, R>::value;     \
     using type = typename                                                      \
                  std::conditional<value,                                       \
                                   has_member_##Member##_tag,                   \
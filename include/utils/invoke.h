@@ -20,6 +20,8 @@
 #include "meta.h"
 
 #include <std14/utility>
+#include <cstddef>
+#include <tuple>
 #include <type_traits>
 
 
@@ -140,7 +142,7 @@ namespace details {
      * The apply function does the same things as invoke() but accepts arguments
      * from an std::tuple
      */
-    template<typename F, typename Tuple, size_t ...Idx>
+    template<typename F, typename Tuple, std::size_t ...Idx>
     auto apply_impl(F&& f, Tuple&& tuple, std14::index_sequence<Idx...>)
         declreturn(invoke(std::forward<F>(f),
                           std::get<Idx>(std::forward<Tuple>(tuple))...))
@@ -150,7 +152,9 @@ namespace details {
         declreturn(apply_impl(std::forward<F>(f),
                               std::forward<Tuple>(tuple),
                               std14::make_index_sequence<
-                                std::tuple_size<Tuple>::value
+                                std::tuple_size<
+                                  typename std::decay<Tuple>::type
+                                >::value
                               >()))
     
     #undef declreturn
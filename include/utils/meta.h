@@ -17,11 +17,18 @@
 #ifndef CPPUTILS_META_H
 #define CPPUTILS_META_H
 
+#include <cstddef>
 #include <type_traits>
 
 #define CPPUTILS_CONCAT__(x, y) CPPUTILS_CONCAT_2__(x,y)
 #define CPPUTILS_CONCAT_2__(x, y) x ## y
 
+/*
+ * The fresh name is taken from __LINE__ rather than __COUNTER__, because it
+ * has to be the same in every translation unit including a given template,
+ * or the ODR would be violated. That's why multiple REQUIRES in the same
+ * template have to be on different lines.
+ */
 #define CPPUTILS_REQUIRES_FRESH CPPUTILS_CONCAT__(UNFULFILLED_TEMPLATE_REQUIREMENT_, __LINE__)
 
 
@@ -29,6 +36,19 @@
 #define REQUIRES(...) \
 typename CPPUTILS_REQUIRES_FRESH = void, typename std::enable_if<::utils::details::true_t<CPPUTILS_REQUIRES_FRESH>::value && ::utils::details::all(__VA_ARGS__), int>::type = 0
 
+/*
+ * all() and any() don't recurse on their arguments, to keep the number of
+ * instantiations low in heavily constrained code. Each argument is turned
+ * into a bool with metavalue(), and the bools are combined with a fold
+ * expression where available. Otherwise they're put in an array, whose
+ * constexpr member functions split it in halves, so that a single
+ * instantiation per number of arguments is needed, with logarithmic
+ * constexpr evaluation depth.
+ */
+#if defined(__cpp_fold_expressions) && __cpp_fold_expressions >= 201603
+#define CPPUTILS_HAS_FOLD_EXPRESSIONS 1
+#endif
+
 namespace utils {
     
     namespace details
@@ -39,6 +59,16 @@ namespace utils {
         template<typename T>
         using void_t = void;
 
+        template<bool ...>
+        struct bool_pack { };
+        
+        /*
+         * Type-level conjunction of a pack of booleans, without recursion
+         */
+        template<bool ...B>
+        using all_of = std::is_same<bool_pack<true, B...>,
+                                    bool_pack<B..., true>>;
+        
         template<typename T, bool Tb = T::value>
         constexpr bool metapredicate() {
             return Tb;
@@ -49,36 +79,66 @@ namespace utils {
             return B;
         }
         
-        constexpr bool all() { return true; }
+        // Value of a requirement, be it a bool or a type trait instance
+        constexpr bool metavalue(bool b) { return b; }
+        
+        template<typename T, bool Tb = T::value>
+        constexpr bool metavalue(T) { return Tb; }
         
+#ifdef CPPUTILS_HAS_FOLD_EXPRESSIONS
         template<typename ...Args>
-        constexpr
-        bool all(bool b, Args ...args)
-        {
-            return b && all(args...);
+        constexpr bool all(Args ...args) {
+            return (true && ... && metavalue(args));
         }
         
-        template<typename T, typename ...Args, bool Tb = T::value>
-        constexpr
-        bool all(T, Args ...args)
+        template<typename ...Args>
+        constexpr bool any(Args ...args) {
+            return (false || ... || metavalue(args));
+        }
+#else
+        template<std::size_t N>
+        struct bool_array
         {
-            return Tb && all(args...);
+            bool values[N];
+            
+            constexpr bool all(std::size_t b = 0, std::size_t e = N) const {
+                return e - b == 0 ? true :
+                       e - b == 1 ? values[b] :
+                       all(b, b + (e - b) / 2) && all(b + (e - b) / 2, e);
+            }
+            
+            constexpr bool any(std::size_t b = 0, std::size_t e = N) const {
+                return e - b == 0 ? false :
+                       e - b == 1 ? values[b] :
+                       any(b, b + (e - b) / 2) || any(b + (e - b) / 2, e);
+            }
+        };
+        
+        // The leading element avoids zero-sized arrays
+        template<typename ...Args>
+        constexpr bool all(Args ...args) {
+            return bool_array<sizeof...(Args) + 1>{{
+                true, metavalue(args)...
+            }}.all();
+        }
+        
+        template<typename ...Args>
+        constexpr bool any(Args ...args) {
+            return bool_array<sizeof...(Args) + 1>{{
+                false, metavalue(args)...
+            }}.any();
         }
+#endif
         
         template<typename T, typename ...Args>
         constexpr bool same_type() {
-            return all(std::is_same<T, Args>()...);
+            return all_of<std::is_same<T, Args>::value...>::value;
         }
         
         constexpr bool neg(bool b) { return not b; }
         
         template<typename T, bool Tb = T::value>
         constexpr bool neg(T) { return not Tb; }
-        
-        template<typename ...Args>
-        constexpr bool any(Args ...args) {
-            return not all(neg(args)...);
-        }
     }
     
     using details::true_t;
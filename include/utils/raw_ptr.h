@@ -19,6 +19,7 @@
 
 #include "meta.h"
 
+#include <cstddef>
 #include <utility>
 #include <std14/type_traits>
 
@@ -154,7 +155,7 @@ namespace details {
         }
         
         // The array version adds an indexing operator 
-        T &operator[](size_t i) const {
+        T &operator[](std::size_t i) const {
             return _ptr[i];
         }
     };
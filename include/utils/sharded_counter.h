@@ -0,0 +1,130 @@
+/*
+ * Copyright 2014 Nicola Gigante
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CPPUTILS_SHARDED_COUNTER_H
+#define CPPUTILS_SHARDED_COUNTER_H
+
+#include "support.h"
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+/*
+ * A counter meant to be incremented concurrently by a lot of threads and
+ * read only once in a while (statistics, metrics, reference counts
+ * that only need to be exact at the end, etc...).
+ *
+ * A single std::atomic bounces its cache line between every core that
+ * touches it. Here instead the count is split into Shards atomics, each
+ * sitting in its own cache line, and each thread always increments the same
+ * shard, chosen round-robin the first time the thread touches any counter.
+ * Increments are thus uncontended as long as there are less threads than
+ * shards, while reads have to sum all the shards.
+ *
+ * The value returned by load() is not a snapshot: increments happening
+ * concurrently with the read may or may not be counted.
+ *
+ *     utils::sharded_counter<> requests;
+ *
+ *     // On any thread
+ *     ++requests;
+ *
+ *     // Later
+ *     std::cout << requests.load() << std::endl;
+ */
+
+namespace utils {
+namespace details {
+
+    /*
+     * Index of the shard used by the calling thread, shared among all the
+     * counters. The modulo is taken by the counter itself.
+     */
+    inline std::size_t this_thread_shard() noexcept
+    {
+        static std::atomic<std::size_t> next{0};
+        static thread_local std::size_t shard =
+            next.fetch_add(1, std::memory_order_relaxed);
+
+        return shard;
+    }
+
+    template<typename T = std::size_t, std::size_t Shards = 32>
+    class sharded_counter
+    {
+        static_assert(std::is_integral<T>::value,
+                      "sharded_counter needs an integral type");
+        static_assert(Shards > 0 && (Shards & (Shards - 1)) == 0,
+                      "The number of shards must be a power of two");
+
+    public:
+        using value_type = T;
+
+        static constexpr std::size_t shards = Shards;
+
+        sharded_counter() = default;
+
+        sharded_counter(sharded_counter const&) = delete;
+        sharded_counter &operator=(sharded_counter const&) = delete;
+
+        void add(T n) noexcept {
+            _shards[this_thread_shard() & (Shards - 1)]->fetch_add(
+                n, std::memory_order_relaxed);
+        }
+
+        void sub(T n) noexcept {
+            _shards[this_thread_shard() & (Shards - 1)]->fetch_sub(
+                n, std::memory_order_relaxed);
+        }
+
+        sharded_counter &operator+=(T n) noexcept { add(n); return *this; }
+        sharded_counter &operator-=(T n) noexcept { sub(n); return *this; }
+
+        // Increments and decrements don't return the value on purpose:
+        // that would need to read all the shards.
+        void operator++() noexcept { add(1); }
+        void operator--() noexcept { sub(1); }
+
+        T load() const noexcept {
+            T sum = 0;
+            for(auto const&s : _shards)
+                sum += s->load(std::memory_order_relaxed);
+            return sum;
+        }
+
+        explicit operator T() const noexcept { return load(); }
+
+        // Not atomic with respect to concurrent increments
+        void reset() noexcept {
+            for(auto &s : _shards)
+                s->store(0, std::memory_order_relaxed);
+        }
+
+    private:
+        cache_aligned<std::atomic<T>> _shards[Shards];
+    };
+
+    template<typename T, std::size_t Shards>
+    constexpr std::size_t sharded_counter<T, Shards>::shards;
+
+} // namespace details
+
+using details::sharded_counter;
+
+} // namespace utils
+
+#endif
@@ -0,0 +1,468 @@
+/*
+ * Copyright 2014 Nicola Gigante
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CPPUTILS_STRING_BUILDER_H
+#define CPPUTILS_STRING_BUILDER_H
+
+/*
+ * A string builder that appends into a chain of arena chunks, instead of
+ * reallocating and copying the whole string when it grows like
+ * std::string does.
+ *
+ *     utils::string_builder b;
+ *     b << "GET " << path << " HTTP/1.1\r\n"
+ *       << "Content-Length: " << length << "\r\n";
+ *
+ * When done, the result can be taken in two ways:
+ *
+ *   - str() returns a contiguous string_view. If the content spans more than
+ *     one chunk, it's copied once into a single buffer sized exactly.
+ *   - chunks() (or iovecs() on POSIX systems) returns the list of chunks,
+ *     ready to be written with writev() without any copy.
+ *
+ * Views returned by str() and chunks() point into the builder, so they stay
+ * valid until the builder is modified or destroyed. Note that str() itself
+ * counts as a modification when it has to copy: it replaces all the chunks
+ * with a single one, invalidating what chunks() and iovecs() returned before.
+ *
+ * Integers are formatted two digits at a time, floating point numbers with
+ * std::to_chars, which gives the shortest representation that round-trips,
+ * where available, and with snprintf otherwise. Bools are written as "true"
+ * and "false", enums as their underlying integer.
+ */
+
+#include "meta.h"
+#include "support.h"
+
+#include <std14/experimental/string_view>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if __cplusplus >= 201703L && defined(__has_include)
+# if __has_include(<charconv>)
+#  include <charconv>
+# endif
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+# include <sys/uio.h>
+# define CPPUTILS_HAS_IOVEC
+#endif
+
+namespace utils {
+namespace details {
+
+    /*
+     * Maximum number of chars needed to format any value of type T,
+     * sign included
+     */
+    template<typename T>
+    constexpr std::size_t integer_size() {
+        return std::size_t(std::numeric_limits<
+                   typename std::make_unsigned<T>::type>::digits10) + 2;
+    }
+
+    /*
+     * Formats value into out, which must have room for at least
+     * integer_size<T>() chars, and returns the number of chars written
+     */
+    template<typename T>
+    std::size_t format_integer(char *out, T value) noexcept
+    {
+        static char const digits[] =
+            "00010203040506070809"
+            "10111213141516171819"
+            "20212223242526272829"
+            "30313233343536373839"
+            "40414243444546474849"
+            "50515253545556575859"
+            "60616263646566676869"
+            "70717273747576777879"
+            "80818283848586878889"
+            "90919293949596979899";
+
+        using U = typename std::make_unsigned<T>::type;
+        static_assert(std::numeric_limits<U>::is_specialized,
+                      "No numeric_limits for this integer type");
+
+        bool negative = value < 0;
+        U u = negative ? U(U(0) - U(value)) : U(value);
+
+        char buf[integer_size<T>()];
+        char *end = buf + sizeof(buf);
+        char *p = end;
+
+        while(u >= 100) {
+            unsigned i = unsigned(u % 100) * 2;
+            u /= 100;
+            *--p = digits[i + 1];
+            *--p = digits[i];
+        }
+
+        if(u >= 10) {
+            unsigned i = unsigned(u) * 2;
+            *--p = digits[i + 1];
+            *--p = digits[i];
+        } else
+            *--p = char('0' + u);
+
+        if(negative)
+            *--p = '-';
+
+        std::size_t size = std::size_t(end - p);
+        std::memcpy(out, p, size);
+        return size;
+    }
+
+    /*
+     * Formats value into out, which has room for size chars, and returns the
+     * number of chars written, or zero if they don't fit
+     */
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    template<typename T>
+    std::size_t format_float(char *out, std::size_t size, T value) noexcept {
+        auto result = std::to_chars(out, out + size, value);
+        if(result.ec != std::errc())
+            return 0;
+        return std::size_t(result.ptr - out);
+    }
+#else
+    template<typename T>
+    std::size_t format_float(char *out, std::size_t size, T value) noexcept {
+        int n = std::snprintf(out, size, "%.*Lg",
+                              std::numeric_limits<T>::max_digits10,
+                              static_cast<long double>(value));
+        return n < 0 ? 0 : std::min(std::size_t(n), size - 1);
+    }
+#endif
+
+    class string_builder
+    {
+    public:
+        using string_view = std14::experimental::string_view;
+
+    private:
+        // Chunks are allocated as a single block, with the data following
+        // the header
+        struct chunk {
+            chunk *next;
+            std::size_t capacity;
+            std::size_t size;
+
+            char *data() noexcept {
+                return reinterpret_cast<char *>(this + 1);
+            }
+
+            std::size_t available() const noexcept {
+                return capacity - size;
+            }
+        };
+
+        // Chunks grow geometrically up to this size
+        static constexpr std::size_t max_chunk_size = std::size_t(1) << 20;
+
+        // Room needed to format any floating point number in place
+        static constexpr std::size_t max_float_size = 48;
+
+    public:
+        explicit string_builder(std::size_t chunk_size = 4096) noexcept
+            : _chunk_size(std::max(chunk_size, std::size_t(64))) { }
+
+        string_builder(string_builder const&) = delete;
+        string_builder &operator=(string_builder const&) = delete;
+
+        string_builder(string_builder &&other) noexcept
+            : _head(other._head), _tail(other._tail), _size(other._size),
+              _chunk_size(other._chunk_size)
+        {
+            other._head = other._tail = nullptr;
+            other._size = 0;
+        }
+
+        string_builder &operator=(string_builder &&other) noexcept {
+            std::swap(_head, other._head);
+            std::swap(_tail, other._tail);
+            std::swap(_size, other._size);
+            std::swap(_chunk_size, other._chunk_size);
+            return *this;
+        }
+
+        ~string_builder() { release(_head); }
+
+        std::size_t size() const noexcept { return _size; }
+        bool empty() const noexcept { return _size == 0; }
+
+        /*
+         * Appending
+         */
+        string_builder &append(string_view str)
+        {
+            char const *data = str.data();
+            std::size_t size = str.size();
+
+            while(size > 0) {
+                if(!_tail || _tail->available() == 0)
+                    grow(size);
+
+                std::size_t n = std::min(size, _tail->available());
+                std::memcpy(_tail->data() + _tail->size, data, n);
+                _tail->size += n;
+                _size += n;
+                data += n;
+                size -= n;
+            }
+
+            return *this;
+        }
+
+        // A template, so that nothing else converts to char: bools and
+        // enums would otherwise be written as raw bytes
+        template<typename T, REQUIRES(std::is_same<T, char>())>
+        string_builder &append(T c)
+        {
+            if(UTILS_UNLIKELY(!_tail || _tail->available() == 0))
+                grow(1);
+
+            _tail->data()[_tail->size++] = c;
+            ++_size;
+            return *this;
+        }
+
+        string_builder &append(char c, std::size_t count)
+        {
+            while(count > 0) {
+                if(!_tail || _tail->available() == 0)
+                    grow(count);
+
+                std::size_t n = std::min(count, _tail->available());
+                std::memset(_tail->data() + _tail->size, c, n);
+                _tail->size += n;
+                _size += n;
+                count -= n;
+            }
+
+            return *this;
+        }
+
+        // A template too, so that pointers don't convert to bool
+        template<typename T, REQUIRES(std::is_same<T, bool>())>
+        string_builder &append(T value) {
+            return append(value ? string_view("true", 4)
+                                : string_view("false", 5));
+        }
+
+        template<typename T,
+                 REQUIRES(std::is_integral<T>(),
+                          neg(std::is_same<T, bool>()),
+                          neg(std::is_same<T, char>()))>
+        string_builder &append(T value)
+        {
+            constexpr std::size_t room = integer_size<T>();
+
+            if(UTILS_LIKELY(_tail && _tail->available() >= room))
+                commit(format_integer(_tail->data() + _tail->size, value));
+            else {
+                char buf[room];
+                append(string_view(buf, format_integer(buf, value)));
+            }
+
+            return *this;
+        }
+
+        // Enums are written as their underlying integer, promoted so
+        // that a char-based one isn't written as a character
+        template<typename T, REQUIRES(std::is_enum<T>())>
+        string_builder &append(T value) {
+            using U = typename std::underlying_type<T>::type;
+            return append(+static_cast<U>(value));
+        }
+
+        template<typename T, REQUIRES(std::is_floating_point<T>())>
+        string_builder &append(T value)
+        {
+            if(UTILS_LIKELY(_tail && _tail->available() >= max_float_size))
+                commit(format_float(_tail->data() + _tail->size,
+                                    max_float_size, value));
+            else {
+                char buf[max_float_size];
+                append(string_view(buf,
+                                   format_float(buf, max_float_size, value)));
+            }
+
+            return *this;
+        }
+
+        template<typename T>
+        auto operator<<(T&& value)
+            -> decltype(append(std::forward<T>(value)))
+        {
+            return append(std::forward<T>(value));
+        }
+
+        /*
+         * Makes sure the next n bytes can be appended without allocating
+         */
+        void reserve(std::size_t n) {
+            if(!_tail || _tail->available() < n)
+                grow(n, n);
+        }
+
+        // Empties the builder, keeping the first chunk for reuse
+        void clear() noexcept
+        {
+            if(!_head)
+                return;
+
+            release(_head->next);
+            _head->next = nullptr;
+            _head->size = 0;
+            _tail = _head;
+            _size = 0;
+        }
+
+        /*
+         * Getting the result
+         */
+
+        // Contiguous view of the whole content. Copies it at most once,
+        // releasing the old chunks, so earlier chunks() become dangling.
+        string_view str()
+        {
+            if(!_head)
+                return { };
+
+            if(_head->next && _size > 0) {
+                chunk *c = allocate(_size);
+                for(chunk *p = _head; p; p = p->next) {
+                    std::memcpy(c->data() + c->size, p->data(), p->size);
+                    c->size += p->size;
+                }
+
+                release(_head);
+                _head = _tail = c;
+            }
+
+            return string_view(_head->data(), _head->size);
+        }
+
+        // Non-empty chunks, in order, without copying them
+        std::vector<string_view> chunks() const
+        {
+            std::vector<string_view> result;
+            result.reserve(count());
+            for(chunk *p = _head; p; p = p->next)
+                if(p->size > 0)
+                    result.emplace_back(p->data(), p->size);
+
+            return result;
+        }
+
+#ifdef CPPUTILS_HAS_IOVEC
+        // Same as chunks(), ready to be passed to writev()
+        std::vector<iovec> iovecs() const
+        {
+            std::vector<iovec> result;
+            result.reserve(count());
+            for(chunk *p = _head; p; p = p->next)
+                if(p->size > 0)
+                    result.push_back({ p->data(), p->size });
+
+            return result;
+        }
+#endif
+
+        std::string to_string() const
+        {
+            std::string result;
+            result.reserve(_size);
+            for(chunk *p = _head; p; p = p->next)
+                result.append(p->data(), p->size);
+
+            return result;
+        }
+
+    private:
+        std::size_t count() const noexcept {
+            std::size_t n = 0;
+            for(chunk *p = _head; p; p = p->next)
+                n += p->size > 0;
+            return n;
+        }
+
+        static chunk *allocate(std::size_t capacity)
+        {
+            void *memory = ::operator new(sizeof(chunk) + capacity);
+            return new (memory) chunk{ nullptr, capacity, 0 };
+        }
+
+        static void release(chunk *c) noexcept
+        {
+            while(c) {
+                chunk *next = c->next;
+                ::operator delete(c);
+                c = next;
+            }
+        }
+
+        /*
+         * Appends a new chunk big enough for the upcoming data, but at
+         * least of size needed. The leftover space of the current chunk is
+         * wasted only if it can't contain what's needed.
+         */
+        UTILS_NOINLINE
+        void grow(std::size_t hint, std::size_t needed = 1)
+        {
+            std::size_t const max = max_chunk_size;
+            std::size_t capacity = _tail ? std::min(_tail->capacity * 2, max)
+                                         : _chunk_size;
+            capacity = std::max({ capacity, std::min(hint, max), needed });
+
+            chunk *c = allocate(capacity);
+            if(_tail)
+                _tail->next = c;
+            else
+                _head = c;
+            _tail = c;
+        }
+
+        void commit(std::size_t n) noexcept {
+            _tail->size += n;
+            _size += n;
+        }
+
+        chunk *_head = nullptr;
+        chunk *_tail = nullptr;
+        std::size_t _size = 0;
+        std::size_t _chunk_size;
+    };
+
+} // namespace details
+
+using details::string_builder;
+
+} // namespace utils
+
+#endif
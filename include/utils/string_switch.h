@@ -75,7 +75,7 @@ namespace details
     /*
      * General flexible version
      */
-    uint64_t str_switch(string_view str) {
+    inline uint64_t str_switch(string_view str) {
         return hash(str.data(), str.size());
     }
     
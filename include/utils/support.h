@@ -10,8 +10,11 @@
 #ifndef CPPUTILS_SUPPORT_H
 #define CPPUTILS_SUPPORT_H
 
+#include <cstddef>
 #include <cstdio>
 #include <cstdlib>
+#include <type_traits>
+#include <utility>
 
 /*
  * These are compiler compatibility macros, imported from LLVM Compiler.h
@@ -54,6 +57,48 @@
 # define UTILS_BUILTIN_UNREACHABLE __builtin_unreachable()
 #endif
 
+/*
+ * UTILS_LIKELY(expr) and UTILS_UNLIKELY(expr) tell the optimizer which way a
+ * branch is expected to go, so that the hot path is laid out as fall-through.
+ */
+#if __has_builtin(__builtin_expect) || UTILS_GNUC_PREREQ(4, 0, 0)
+# define UTILS_LIKELY(EXPR) __builtin_expect(static_cast<bool>(EXPR), true)
+# define UTILS_UNLIKELY(EXPR) __builtin_expect(static_cast<bool>(EXPR), false)
+#else
+# define UTILS_LIKELY(EXPR) (EXPR)
+# define UTILS_UNLIKELY(EXPR) (EXPR)
+#endif
+
+/*
+ * UTILS_FORCE_INLINE forces a function to be inlined, UTILS_NOINLINE prevents
+ * it. The former already implies 'inline', so don't repeat it.
+ */
+#if __has_attribute(always_inline) || UTILS_GNUC_PREREQ(4, 0, 0)
+# define UTILS_FORCE_INLINE inline __attribute__((always_inline))
+#elif defined(_MSC_VER)
+# define UTILS_FORCE_INLINE __forceinline
+#else
+# define UTILS_FORCE_INLINE inline
+#endif
+
+#if __has_attribute(noinline) || UTILS_GNUC_PREREQ(3, 4, 0)
+# define UTILS_NOINLINE __attribute__((noinline))
+#elif defined(_MSC_VER)
+# define UTILS_NOINLINE __declspec(noinline)
+#else
+# define UTILS_NOINLINE
+#endif
+
+/*
+ * UTILS_RESTRICT promises the compiler that a pointer doesn't alias any other
+ * pointer accessible in the same scope.
+ */
+#if defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER)
+# define UTILS_RESTRICT __restrict
+#else
+# define UTILS_RESTRICT
+#endif
+
 /*
  * code_unreachable() marks a given execution path as unreachable
  */
@@ -63,7 +108,90 @@
 #  define code_unreachable() ::utils::details::unreachable(__FILE__, __LINE__, __func__);
 #endif
 
+/*
+ * UTILS_ASSUME(cond) lets the optimizer assume that cond holds. The condition
+ * must be free of side effects: it may or may not be evaluated.
+ */
+#if __has_builtin(__builtin_assume)
+# define UTILS_ASSUME(COND) __builtin_assume(COND)
+#elif defined(_MSC_VER)
+# define UTILS_ASSUME(COND) __assume(COND)
+#elif defined(UTILS_BUILTIN_UNREACHABLE)
+# define UTILS_ASSUME(COND) \
+    ((COND) ? static_cast<void>(0) : UTILS_BUILTIN_UNREACHABLE)
+#else
+# define UTILS_ASSUME(COND) static_cast<void>(0)
+#endif
+
+/*
+ * The size of a cache line, that is, the granularity at which two
+ * different cores fight over the same memory. It can be overridden from the
+ * command line if the target is known to differ.
+ */
+#ifndef UTILS_CACHE_LINE_SIZE
+# if defined(__APPLE__) && defined(__aarch64__)
+#  define UTILS_CACHE_LINE_SIZE 128
+# else
+#  define UTILS_CACHE_LINE_SIZE 64
+# endif
+#endif
+
 namespace utils {
+    
+    constexpr std::size_t cache_line_size = UTILS_CACHE_LINE_SIZE;
+    
+    /*
+     * prefetch<Locality>(addr) hints the processor to bring the cache line
+     * containing addr closer to the core. Locality goes from 0 (no temporal
+     * locality, don't pollute the caches) to 3 (keep it in every level).
+     * Pass Write = true if the line is going to be modified.
+     */
+    template<unsigned Locality = 3, bool Write = false>
+    UTILS_FORCE_INLINE
+    void prefetch(void const *addr) noexcept
+    {
+        static_assert(Locality <= 3, "Prefetch locality must be in [0, 3]");
+#if __has_builtin(__builtin_prefetch) || UTILS_GNUC_PREREQ(3, 1, 0)
+        __builtin_prefetch(addr, Write ? 1 : 0, Locality);
+#else
+        static_cast<void>(addr);
+#endif
+    }
+    
+    /*
+     * cache_aligned<T> wraps an object of type T so that it sits alone in its
+     * own cache line(s). Useful to avoid false sharing between objects
+     * written by different threads, e.g. in an array of per-thread counters.
+     *
+     * Note that before C++17 operator new doesn't honor over-aligned types,
+     * so heap-allocated instances are only padded, not necessarily aligned.
+     */
+    template<typename T>
+    class alignas(cache_line_size) cache_aligned
+    {
+    public:
+        constexpr cache_aligned() : _value() { }
+        
+        template<typename Arg, typename ...Args,
+                 typename = typename std::enable_if<
+                     std::is_constructible<T, Arg, Args...>::value
+                 >::type>
+        constexpr cache_aligned(Arg&& arg, Args&& ...args)
+            : _value(std::forward<Arg>(arg), std::forward<Args>(args)...) { }
+        
+        T       &get()       noexcept { return _value; }
+        T const &get() const noexcept { return _value; }
+        
+        T       &operator*()       noexcept { return _value; }
+        T const &operator*() const noexcept { return _value; }
+        
+        T       *operator->()       noexcept { return &_value; }
+        T const *operator->() const noexcept { return &_value; }
+        
+    private:
+        T _value;
+    };
+    
 namespace details {
     
     [[noreturn]]
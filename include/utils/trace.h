@@ -0,0 +1,658 @@
+/*
+ * Copyright 2014 Nicola Gigante
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CPPUTILS_TRACE_H
+#define CPPUTILS_TRACE_H
+
+/*
+ * Low-overhead scoped tracing.
+ *
+ * UTILS_TRACE_SCOPE("name") records the time spent from the point it appears
+ * to the end of the enclosing scope. The name must be a string literal: it's
+ * hashed at compile time with the ""_match literal from string_switch.h.
+ *
+ *     void handle(request const&r) {
+ *         UTILS_TRACE_SCOPE("handle");
+ *         ...
+ *     }
+ *
+ * The scope's tracer variable is named after __LINE__, so there can be only
+ * one UTILS_TRACE_SCOPE per line. __COUNTER__ would give different names to
+ * the same inline function in different translation units, breaking the ODR.
+ *
+ * Tracing is compiled in only if UTILS_ENABLE_TRACING is defined. Otherwise
+ * the macro expands to an empty statement and costs nothing.
+ *
+ * Each thread writes its events into its own lock-free ring buffer, so
+ * recording a scope costs two timestamps (rdtsc on x86, steady_clock
+ * elsewhere or if UTILS_TRACE_STEADY_CLOCK is defined) and a store.
+ * If a buffer fills up before being collected, new events are dropped.
+ *
+ * Events are collected by the tracer singleton, either on demand with
+ * tracer::instance().dump(path), or periodically by a background thread
+ * started with start_flushing(path, period). Both write Chrome's trace_event
+ * JSON format, which can be opened in Perfetto or in chrome://tracing.
+ * Collected events also feed a per-scope histogram of durations, from which
+ * percentiles can be queried at runtime with tracer::instance().stats(name).
+ *
+ * Events drained by collect() or stats() are kept for export only while
+ * the background flusher runs, or after capture(true). Otherwise they only
+ * update the histograms, and dump() writes just the events recorded since
+ * the last collection.
+ */
+
+#include "meta.h"
+#include "string_switch.h"
+#include "support.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _MSC_VER
+# include <intrin.h>
+#endif
+
+#if !defined(UTILS_TRACE_STEADY_CLOCK) && \
+    (defined(__x86_64__) || defined(__i386__) || \
+     defined(_M_X64) || defined(_M_IX86))
+# define UTILS_TRACE_RDTSC
+# ifndef _MSC_VER
+#  include <x86intrin.h>
+# endif
+#endif
+
+// Number of events each thread can buffer between two collections.
+#ifndef UTILS_TRACE_BUFFER_SIZE
+# define UTILS_TRACE_BUFFER_SIZE 16384
+#endif
+
+// Number of collected events kept in memory waiting to be written out.
+#ifndef UTILS_TRACE_MAX_PENDING
+# define UTILS_TRACE_MAX_PENDING 1048576
+#endif
+
+#ifdef UTILS_ENABLE_TRACING
+# define UTILS_TRACE_SCOPE(NAME)                                              \
+    ::utils::details::scope_tracer                                            \
+    CPPUTILS_CONCAT__(utils_trace_scope_, __LINE__)(                          \
+        ::std::integral_constant<                                             \
+            ::std::uint64_t,                                                  \
+            ::utils::literals::operator""_match(NAME, sizeof(NAME) - 1)       \
+        >::value, NAME)
+#else
+# define UTILS_TRACE_SCOPE(NAME) static_cast<void>(0)
+#endif
+
+namespace utils {
+namespace details {
+
+    /*
+     * The clock used for timestamps. Its ticks are converted to nanoseconds
+     * only when events are collected.
+     */
+    UTILS_FORCE_INLINE
+    uint64_t trace_clock() noexcept
+    {
+#ifdef UTILS_TRACE_RDTSC
+        return __rdtsc();
+#else
+        return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+    }
+
+    inline uint64_t steady_nanoseconds() noexcept {
+        return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    struct trace_event {
+        uint64_t id;
+        char const *name;
+        uint64_t begin;
+        uint64_t end;
+    };
+
+    /*
+     * Single-producer single-consumer ring buffer. The owning thread pushes,
+     * the tracer drains. Head and tail live on different cache lines, and
+     * the producer only rereads the tail when the buffer looks full.
+     */
+    class trace_buffer
+    {
+        static constexpr uint64_t capacity = UTILS_TRACE_BUFFER_SIZE;
+        static_assert((capacity & (capacity - 1)) == 0,
+                      "UTILS_TRACE_BUFFER_SIZE must be a power of two");
+
+    public:
+        explicit trace_buffer(unsigned tid)
+            : _events(new trace_event[capacity]), _tid(tid) { }
+
+        unsigned tid() const noexcept { return _tid; }
+
+        void push(trace_event const&e) noexcept
+        {
+            uint64_t h = _head->load(std::memory_order_relaxed);
+
+            if(UTILS_UNLIKELY(h - _cached_tail == capacity)) {
+                _cached_tail = _tail->load(std::memory_order_acquire);
+                if(h - _cached_tail == capacity) {
+                    _dropped.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+            }
+
+            _events[h & (capacity - 1)] = e;
+            _head->store(h + 1, std::memory_order_release);
+        }
+
+        template<typename F>
+        void drain(F&& f)
+        {
+            uint64_t t = _tail->load(std::memory_order_relaxed);
+            uint64_t h = _head->load(std::memory_order_acquire);
+
+            for(; t != h; ++t)
+                f(_events[t & (capacity - 1)]);
+
+            _tail->store(h, std::memory_order_release);
+        }
+
+        uint64_t take_dropped() noexcept {
+            return _dropped.exchange(0, std::memory_order_relaxed);
+        }
+
+        // Set when the owning thread exits
+        std::atomic<bool> retired{false};
+
+    private:
+        std::unique_ptr<trace_event[]> _events;
+        unsigned _tid;
+
+        cache_aligned<std::atomic<uint64_t>> _head;
+        uint64_t _cached_tail = 0;
+
+        cache_aligned<std::atomic<uint64_t>> _tail;
+        std::atomic<uint64_t> _dropped{0};
+    };
+
+    /*
+     * Log-linear histogram of durations in nanoseconds: each power of two
+     * is split into 16 linear sub-buckets, so the relative error of the
+     * reported percentiles is at most ~6%.
+     */
+    class trace_histogram
+    {
+        static constexpr unsigned sub_bits = 4;
+        static constexpr unsigned sub_buckets = 1 << sub_bits;
+        static constexpr unsigned buckets = (64 - sub_bits + 1) * sub_buckets;
+
+    public:
+        void record(uint64_t ns) noexcept {
+            ++_counts[index(ns)];
+            ++_count;
+            _max = std::max(_max, ns);
+        }
+
+        uint64_t count() const noexcept { return _count; }
+        uint64_t max() const noexcept { return _max; }
+
+        // Value under which a fraction q of the recorded durations falls
+        uint64_t percentile(double q) const noexcept
+        {
+            if(_count == 0)
+                return 0;
+
+            uint64_t rank = uint64_t(q * double(_count - 1)) + 1;
+            uint64_t seen = 0;
+            for(unsigned i = 0; i < buckets; ++i) {
+                seen += _counts[i];
+                if(seen >= rank)
+                    return std::min(upper_bound(i), _max);
+            }
+
+            return _max;
+        }
+
+    private:
+        // Index of the most significant set bit. v must not be zero.
+        static unsigned msb(uint64_t v) noexcept {
+#if __has_builtin(__builtin_clzll) || UTILS_GNUC_PREREQ(3, 4, 0)
+            return unsigned(63 - __builtin_clzll(v));
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+            unsigned long r;
+            _BitScanReverse64(&r, v);
+            return unsigned(r);
+#else
+            unsigned r = 0;
+            while(v >>= 1)
+                ++r;
+            return r;
+#endif
+        }
+
+        static unsigned index(uint64_t v) noexcept {
+            if(v < sub_buckets)
+                return unsigned(v);
+
+            unsigned m = msb(v);
+            unsigned sub = unsigned(v >> (m - sub_bits)) & (sub_buckets - 1);
+            return (m - sub_bits + 1) * sub_buckets + sub;
+        }
+
+        static uint64_t upper_bound(unsigned i) noexcept {
+            if(i < sub_buckets)
+                return i;
+
+            unsigned m = i / sub_buckets + sub_bits - 1;
+            uint64_t sub = i % sub_buckets;
+            return ((sub_buckets + sub + 1) << (m - sub_bits)) - 1;
+        }
+
+        uint64_t _counts[buckets] = { };
+        uint64_t _count = 0;
+        uint64_t _max = 0;
+    };
+
+    struct scope_stats {
+        uint64_t count = 0;
+        uint64_t p50 = 0;  // nanoseconds
+        uint64_t p99 = 0;
+        uint64_t max = 0;
+    };
+
+    class tracer
+    {
+        struct collected_event {
+            char const *name;
+            unsigned tid;
+            uint64_t begin; // nanoseconds from the tracer creation
+            uint64_t duration;
+        };
+
+    public:
+        static tracer &instance() {
+            static tracer t;
+            return t;
+        }
+
+        tracer(tracer const&) = delete;
+        tracer &operator=(tracer const&) = delete;
+
+        ~tracer() { stop_flushing(); }
+
+        /*
+         * Called once per thread, the first time it records an event
+         */
+        std::shared_ptr<trace_buffer> register_thread()
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            auto buffer = std::make_shared<trace_buffer>(_next_tid++);
+            _buffers.push_back(buffer);
+
+            return buffer;
+        }
+
+        /*
+         * Drains all the threads' buffers, updating the histograms, and
+         * queueing the events for export if the flusher is running or
+         * capture is enabled.
+         */
+        void collect()
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            collect_locked(_capturing || _flushing);
+        }
+
+        /*
+         * While enabled, events drained by collect() and stats() are kept
+         * until the next dump()
+         */
+        void capture(bool enable)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _capturing = enable;
+        }
+
+        /*
+         * Percentiles of the durations of all the collected events of the
+         * scope with the given name
+         */
+        scope_stats stats(char const *name) {
+            return stats(str_switch(name));
+        }
+
+        scope_stats stats(uint64_t id)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            collect_locked(_capturing || _flushing);
+
+            scope_stats s;
+            auto it = _histograms.find(id);
+            if(it != _histograms.end()) {
+                s.count = it->second.count();
+                s.p50 = it->second.percentile(0.50);
+                s.p99 = it->second.percentile(0.99);
+                s.max = it->second.max();
+            }
+
+            return s;
+        }
+
+        // Number of events lost because a thread's buffer was full. They're
+        // neither exported nor counted in the histograms.
+        uint64_t dropped() const noexcept {
+            return _dropped.load(std::memory_order_relaxed);
+        }
+
+        // Number of events counted in the histograms, but not exported
+        // because too many were waiting to be written out
+        uint64_t dropped_from_export() const noexcept {
+            return _dropped_from_export.load(std::memory_order_relaxed);
+        }
+
+        /*
+         * Writes the events still in the threads' buffers, and those kept
+         * for export since the last dump, as a complete Chrome trace JSON
+         * array. While the background flusher runs, they're left queued for
+         * it, so they're written to its file too.
+         */
+        void dump(std::ostream &out)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            collect_locked(true);
+
+            out << "[\n";
+            bool first = true;
+            write_pending(out, first);
+            out << "\n]\n";
+
+            if(!_flushing)
+                _pending.clear();
+        }
+
+        bool dump(char const *path) {
+            std::ofstream out(path);
+            dump(out);
+            return bool(out);
+        }
+
+        /*
+         * Starts a background thread that every period collects the events
+         * and appends them to the file at path. The JSON array is closed by
+         * stop_flushing(), but the trace viewers accept it unterminated too,
+         * so a crashed process still leaves a usable trace.
+         */
+        bool start_flushing(char const *path,
+                            std::chrono::milliseconds period =
+                                std::chrono::milliseconds(100))
+        {
+            stop_flushing();
+
+            std::unique_ptr<std::ofstream> out(new std::ofstream(path));
+            if(!*out)
+                return false;
+            *out << "[\n";
+
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _flushing = true;
+            }
+
+            std::lock_guard<std::mutex> lock(_flusher_mutex);
+            _stop_flushing = false;
+            _flusher = std::thread([this, period](std::ofstream *o) {
+                std::unique_ptr<std::ofstream> out(o);
+                bool first = true;
+
+                std::unique_lock<std::mutex> lock(_flusher_mutex);
+                bool stop = false;
+                while(!stop) {
+                    stop = _flusher_cv.wait_for(lock, period, [this] {
+                        return _stop_flushing;
+                    });
+
+                    std::lock_guard<std::mutex> data_lock(_mutex);
+                    collect_locked(true);
+                    write_pending(*out, first);
+                    _pending.clear();
+                    out->flush();
+                }
+
+                *out << "\n]\n";
+            }, out.release());
+
+            return true;
+        }
+
+        void stop_flushing()
+        {
+            std::thread flusher;
+            {
+                std::lock_guard<std::mutex> lock(_flusher_mutex);
+                _stop_flushing = true;
+                flusher = std::move(_flusher);
+            }
+            _flusher_cv.notify_all();
+
+            if(flusher.joinable())
+                flusher.join();
+
+            std::lock_guard<std::mutex> lock(_mutex);
+            _flushing = false;
+        }
+
+    private:
+        // Spins for a few tens of microseconds to get a first estimate of
+        // the tick rate, refined later by ns_per_tick()
+        tracer()
+            : _start_ticks(trace_clock()),
+              _start_ns(steady_nanoseconds())
+        {
+#ifdef UTILS_TRACE_RDTSC
+            while(trace_clock() - _start_ticks < calibration_ticks)
+                continue;
+            ns_per_tick();
+#endif
+        }
+
+        static constexpr uint64_t calibration_ticks = 100000;
+
+        /*
+         * Ticks to nanoseconds since the tracer creation. With rdtsc, the
+         * ratio is calibrated against steady_clock over the whole lifetime
+         * of the tracer, so it gets more accurate as time passes.
+         */
+        uint64_t to_ns(uint64_t ticks, double ns_per_tick) const noexcept {
+            if(ticks < _start_ticks)
+                return 0;
+            return uint64_t(double(ticks - _start_ticks) * ns_per_tick);
+        }
+
+        double ns_per_tick() const noexcept
+        {
+#ifdef UTILS_TRACE_RDTSC
+            uint64_t ticks = trace_clock() - _start_ticks;
+            uint64_t ns = steady_nanoseconds() - _start_ns;
+
+            if(ticks < calibration_ticks)
+                return _ns_per_tick;
+
+            return _ns_per_tick = double(ns) / double(ticks);
+#else
+            return 1.0;
+#endif
+        }
+
+        void collect_locked(bool export_events)
+        {
+            double ratio = ns_per_tick();
+
+            auto it = _buffers.begin();
+            while(it != _buffers.end()) {
+                auto &buffer = *it;
+                bool retired = buffer->retired.load(std::memory_order_acquire);
+                unsigned tid = buffer->tid();
+
+                buffer->drain([&](trace_event const&e) {
+                    uint64_t begin = to_ns(e.begin, ratio);
+                    uint64_t end = to_ns(e.end, ratio);
+                    uint64_t duration = end > begin ? end - begin : 0;
+
+                    _histograms[e.id].record(duration);
+
+                    if(!export_events)
+                        return;
+
+                    if(_pending.size() < UTILS_TRACE_MAX_PENDING)
+                        _pending.push_back({ e.name, tid, begin, duration });
+                    else
+                        _dropped_from_export.fetch_add(
+                            1, std::memory_order_relaxed);
+                });
+
+                _dropped.fetch_add(buffer->take_dropped(),
+                                   std::memory_order_relaxed);
+
+                // The thread is gone and we've drained everything it wrote
+                if(retired)
+                    it = _buffers.erase(it);
+                else
+                    ++it;
+            }
+        }
+
+        void write_pending(std::ostream &out, bool &first)
+        {
+            for(auto const&e : _pending) {
+                out << (first ? "" : ",\n") << "{\"name\":\"";
+                write_escaped(out, e.name);
+                out << "\",\"cat\":\"utils\",\"ph\":\"X\",\"pid\":1"
+                    << ",\"tid\":" << e.tid
+                    << ",\"ts\":" << e.begin / 1000 << '.'
+                    << fraction(e.begin % 1000)
+                    << ",\"dur\":" << e.duration / 1000 << '.'
+                    << fraction(e.duration % 1000) << '}';
+                first = false;
+            }
+        }
+
+        // Three digits of microseconds fraction, without iostream state
+        static std::string fraction(uint64_t ns) {
+            char digits[4] = {
+                char('0' + ns / 100), char('0' + ns / 10 % 10),
+                char('0' + ns % 10), 0
+            };
+            return digits;
+        }
+
+        static void write_escaped(std::ostream &out, char const *str) {
+            for(; *str; ++str) {
+                if(*str == '"' || *str == '\\')
+                    out << '\\';
+                if(static_cast<unsigned char>(*str) >= 0x20)
+                    out << *str;
+            }
+        }
+
+        std::mutex _mutex;
+        std::vector<std::shared_ptr<trace_buffer>> _buffers;
+        std::unordered_map<uint64_t, trace_histogram> _histograms;
+        std::vector<collected_event> _pending;
+        unsigned _next_tid = 1;
+        std::atomic<uint64_t> _dropped{0};
+        std::atomic<uint64_t> _dropped_from_export{0};
+        bool _capturing = false;
+        bool _flushing = false;
+
+        uint64_t _start_ticks;
+        uint64_t _start_ns;
+        mutable double _ns_per_tick = 1.0;
+
+        std::mutex _flusher_mutex;
+        std::condition_variable _flusher_cv;
+        std::thread _flusher;
+        bool _stop_flushing = false;
+    };
+
+    /*
+     * Owns the calling thread's buffer, and tells the tracer when the
+     * thread exits so that the buffer can be released once drained.
+     */
+    struct thread_trace_buffer {
+        std::shared_ptr<trace_buffer> buffer =
+            tracer::instance().register_thread();
+
+        ~thread_trace_buffer() {
+            buffer->retired.store(true, std::memory_order_release);
+        }
+    };
+
+    inline trace_buffer &this_thread_trace_buffer() {
+        static thread_local thread_trace_buffer b;
+        return *b.buffer;
+    }
+
+    /*
+     * The buffer, and so the tracer, is fetched before taking the first
+     * timestamp, so that the first event of the process doesn't start
+     * before the tracer's time origin.
+     */
+    class scope_tracer
+    {
+    public:
+        UTILS_FORCE_INLINE
+        scope_tracer(uint64_t id, char const *name)
+            : _buffer(this_thread_trace_buffer()), _id(id), _name(name),
+              _begin(trace_clock()) { }
+
+        scope_tracer(scope_tracer const&) = delete;
+        scope_tracer &operator=(scope_tracer const&) = delete;
+
+        UTILS_FORCE_INLINE
+        ~scope_tracer() {
+            uint64_t end = trace_clock();
+            _buffer.push({ _id, _name, _begin, end });
+        }
+
+    private:
+        trace_buffer &_buffer;
+        uint64_t _id;
+        char const *_name;
+        uint64_t _begin;
+    };
+
+} // namespace details
+
+using details::tracer;
+using details::scope_stats;
+
+} // namespace utils
+
+#endif
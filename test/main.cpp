@@ -18,7 +18,11 @@
 #include "utils/meta.h"
 #include "utils/invoke.h"
 #include "utils/raw_ptr.h"
+#include "utils/sharded_counter.h"
+#include "utils/string_builder.h"
 #include "utils/string_switch.h"
+#include "utils/support.h"
+#include "utils/trace.h"
 
 #include <std14/array>
 #include <std14/memory>
@@ -27,10 +31,131 @@
 #include <std14/experimental/array_view>
 #include <std14/experimental/string_view>
 
+#include <climits>
+#include <cstdio>
+#include <string>
+
+// Unlike assert(), also checks in release builds
+#define CHECK(COND)                                                           \
+    ((COND) ? static_cast<void>(0) : fail(#COND, __FILE__, __LINE__))
+
+static int failures = 0;
+
+static void fail(char const *cond, char const *file, int line) {
+    std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, cond);
+    ++failures;
+}
+
+static std::string concat(utils::string_builder const&b) {
+    std::string result;
+    for(auto chunk : b.chunks())
+        result.append(chunk.data(), chunk.size());
+    return result;
+}
+
+static void test_string_builder()
+{
+    using utils::string_builder;
+
+    {
+        string_builder b;
+        b << INT_MIN << ' ' << LLONG_MIN << ' ' << ULLONG_MAX;
+        CHECK(b.to_string() ==
+              "-2147483648 -9223372036854775808 18446744073709551615");
+    }
+
+    {
+        enum E { e_a = 65 };
+        string_builder b;
+        b << true << ' ' << false << ' ' << e_a << ' ' << 'c' << 0.25;
+        CHECK(b.to_string() == "true false 65 c0.25");
+    }
+
+    // Appends crossing chunk boundaries, with the smallest chunk size
+    {
+        string_builder b(64);
+        std::string expected;
+        for(int i = 0; i < 200; ++i) {
+            b << "item " << i * 1000003 << ',';
+            expected += "item " + std::to_string(i * 1000003) + ',';
+            if(i % 50 == 0) {
+                b.append('-', 100);
+                expected.append(100, '-');
+            }
+        }
+
+        CHECK(b.size() == expected.size());
+        CHECK(b.chunks().size() > 1);
+        CHECK(b.to_string() == expected);
+        CHECK(concat(b) == expected);
+
+        auto str = b.str();
+        CHECK(std::string(str.data(), str.size()) == expected);
+        CHECK(b.chunks().size() == 1);
+        CHECK(b.to_string() == expected);
+
+        string_builder moved(std::move(b));
+        CHECK(b.empty());
+        CHECK(b.to_string().empty());
+        CHECK(moved.to_string() == expected);
+
+        b << "other";
+        b = std::move(moved);
+        CHECK(b.to_string() == expected);
+        CHECK(moved.to_string() == "other");
+
+        b.clear();
+        CHECK(b.empty());
+        CHECK(b.to_string().empty());
+        CHECK(b.chunks().empty());
+
+        b << "again " << 42;
+        CHECK(b.to_string() == "again 42");
+        CHECK(concat(b) == "again 42");
+    }
+}
+
+static void test_trace_histogram()
+{
+    using utils::details::trace_histogram;
+
+    trace_histogram empty;
+    CHECK(empty.count() == 0);
+    CHECK(empty.percentile(0.5) == 0);
+
+    // Values under 16 have a bucket each, so they're exact
+    trace_histogram small;
+    for(uint64_t v = 0; v < 16; ++v)
+        small.record(v);
+    CHECK(small.percentile(0) == 0);
+    CHECK(small.percentile(0.5) == 7);
+    CHECK(small.percentile(1) == 15);
+
+    // Larger values are reported with a relative error of at most 1/16,
+    // and never above the maximum
+    trace_histogram h;
+    for(uint64_t v = 1; v <= 100000; ++v)
+        h.record(v);
+    CHECK(h.count() == 100000);
+    CHECK(h.max() == 100000);
+
+    uint64_t p50 = h.percentile(0.50);
+    uint64_t p99 = h.percentile(0.99);
+    CHECK(p50 >= 50000 && p50 <= 50000 + 50000 / 16);
+    CHECK(p99 >= 99000 && p99 <= 100000);
+    CHECK(h.percentile(1) == 100000);
+
+    trace_histogram huge;
+    huge.record(~uint64_t(0));
+    CHECK(huge.percentile(0.5) == ~uint64_t(0));
+}
+
 int main()
 {
     // TODO: Here we should really really test everything...
-    
-    return 0;
+    test_string_builder();
+    test_trace_histogram();
+
+    return failures == 0 ? 0 : 1;
 }
 